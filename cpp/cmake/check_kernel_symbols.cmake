@@ -0,0 +1,34 @@
+# Fails if an ISA kernel object still exports a weak function symbol without
+# its variant prefix, i.e. one the linker could merge with the baseline copy.
+#
+# Usage: cmake -DNM=<nm> -DOBJECTS=<obj;obj> -DPREFIXES=<prefix;prefix>
+#              -P check_kernel_symbols.cmake
+
+list(LENGTH OBJECTS count)
+math(EXPR last "${count} - 1")
+foreach(index RANGE ${last})
+    list(GET OBJECTS ${index} object)
+    list(GET PREFIXES ${index} prefix)
+
+    execute_process(
+        COMMAND ${NM} --defined-only ${object}
+        OUTPUT_VARIABLE symbols
+        RESULT_VARIABLE result
+    )
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Failed to list symbols of ${object}")
+    endif()
+
+    set(shared "")
+    string(REPLACE "\n" ";" lines "${symbols}")
+    foreach(line IN LISTS lines)
+        if(line MATCHES "^[0-9a-fA-F]+ W ([^ ]+)$" AND NOT CMAKE_MATCH_1 MATCHES "^${prefix}")
+            list(APPEND shared ${CMAKE_MATCH_1})
+        endif()
+    endforeach()
+
+    if(shared)
+        message(FATAL_ERROR "${object} exports mergeable weak symbols: ${shared}")
+    endif()
+    message(STATUS "${object}: no mergeable weak symbols")
+endforeach()
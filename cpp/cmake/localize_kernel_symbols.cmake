@@ -0,0 +1,36 @@
+# Renames the weak (COMDAT) function symbols of an ISA kernel object.
+#
+# A kernel variant compiled with e.g. -mavx2 also emits out-of-line copies of
+# std:: templates it uses (std::fill_n, std::min, ...), especially in Debug
+# builds. The linker keeps one copy of each weak symbol library-wide, so the
+# AVX copy could end up called from baseline code on a CPU without AVX.
+# Prefixing those symbols gives every variant its own private copies.
+#
+# Usage: cmake -DNM=<nm> -DOBJCOPY=<objcopy> -DINPUT=<obj> -DOUTPUT=<obj>
+#              -DPREFIX=<prefix> -P localize_kernel_symbols.cmake
+
+execute_process(
+    COMMAND ${NM} --defined-only ${INPUT}
+    OUTPUT_VARIABLE symbols
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Failed to list symbols of ${INPUT}")
+endif()
+
+set(renames "")
+string(REPLACE "\n" ";" lines "${symbols}")
+foreach(line IN LISTS lines)
+    if(line MATCHES "^[0-9a-fA-F]+ W ([^ ]+)$")
+        string(APPEND renames "${CMAKE_MATCH_1} ${PREFIX}${CMAKE_MATCH_1}\n")
+    endif()
+endforeach()
+
+file(WRITE ${OUTPUT}.syms "${renames}")
+execute_process(
+    COMMAND ${OBJCOPY} --redefine-syms=${OUTPUT}.syms ${INPUT} ${OUTPUT}
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Failed to rename symbols of ${INPUT}")
+endif()
@@ -0,0 +1,148 @@
+#include "backgroundvalidator.h"
+#include <exception>
+#include <iostream>
+#include <utility>
+
+/**
+ * @brief Constructs a validator and starts its worker thread
+ * @param evaluate Scoring function run on each snapshot (higher is better)
+ * @param patience Number of evaluations without improvement before stopping is requested
+ * @param minImprovement Minimum score gain that counts as an improvement
+ */
+BackgroundValidator::BackgroundValidator(EvaluateFunction evaluate, int patience, double minImprovement)
+    : evaluate(std::move(evaluate)), patience(patience), minImprovement(minImprovement)
+{
+    worker = std::thread(&BackgroundValidator::workerLoop, this);
+}
+
+/**
+ * @brief Stops the worker thread; a snapshot still waiting for evaluation is discarded
+ */
+BackgroundValidator::~BackgroundValidator() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shuttingDown = true;
+    }
+    wakeWorker.notify_one();
+    worker.join();
+}
+
+/**
+ * @brief Hands a copy of the network's current weights to the worker thread
+ * The copy is made on the caller's thread; the lock is only held to swap the
+ * pending slot, so training never waits for an evaluation to finish. If the
+ * worker is still busy with an older snapshot, the queued one is replaced by
+ * this newer one and counted as skipped.
+ * @param network Live network being trained
+ */
+void BackgroundValidator::submitSnapshot(const NeuralNetwork& network) {
+    auto snapshot = std::make_unique<NeuralNetwork>(network);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending) {
+            skippedCount++;
+        }
+        pending = std::move(snapshot);
+        pendingIndex = submittedCount++;
+    }
+    wakeWorker.notify_one();
+}
+
+/**
+ * @brief Waits until the worker has no queued or in-flight snapshot
+ */
+void BackgroundValidator::waitForIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return !pending && !evaluating; });
+}
+
+/**
+ * @brief Copies the best-scoring snapshot seen so far into the given network
+ * @param network Network to overwrite; must have the same layer sizes
+ * @return bool True if a snapshot was restored
+ */
+bool BackgroundValidator::restoreBest(NeuralNetwork& network) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!best) {
+        return false;
+    }
+    network = *best;
+    return true;
+}
+
+double BackgroundValidator::getBestScore() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bestScore;
+}
+
+int BackgroundValidator::getBestSnapshotIndex() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bestIndex;
+}
+
+int BackgroundValidator::getEvaluatedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return evaluatedCount;
+}
+
+int BackgroundValidator::getFailedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return failedCount;
+}
+
+int BackgroundValidator::getSkippedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return skippedCount;
+}
+
+/**
+ * @brief Worker thread: evaluates snapshots outside the lock and updates the best score
+ */
+void BackgroundValidator::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeWorker.wait(lock, [this] { return pending || shuttingDown; });
+        if (shuttingDown) {
+            return;
+        }
+
+        std::unique_ptr<NeuralNetwork> snapshot = std::move(pending);
+        int index = pendingIndex;
+        evaluating = true;
+
+        // A throwing evaluation must not take down the worker (std::terminate)
+        // or leave `evaluating` set; the snapshot is counted as failed instead
+        bool succeeded = true;
+        double score = 0.0;
+        lock.unlock();
+        try {
+            score = evaluate(*snapshot);
+        } catch (const std::exception& e) {
+            std::cerr << "Error evaluating snapshot " << index << ": " << e.what() << std::endl;
+            succeeded = false;
+        } catch (...) {
+            std::cerr << "Error evaluating snapshot " << index << ": unknown exception" << std::endl;
+            succeeded = false;
+        }
+        lock.lock();
+
+        if (!succeeded) {
+            failedCount++;
+        } else {
+            evaluatedCount++;
+            if (!best || score > bestScore + minImprovement) {
+                best = std::move(snapshot);
+                bestScore = score;
+                bestIndex = index;
+                evaluationsWithoutImprovement = 0;
+            } else if (++evaluationsWithoutImprovement >= patience) {
+                stopRequested.store(true, std::memory_order_release);
+            }
+        }
+
+        evaluating = false;
+        if (!pending) {
+            idle.notify_all();
+        }
+    }
+}
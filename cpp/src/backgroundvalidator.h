@@ -0,0 +1,77 @@
+#ifndef BACKGROUNDVALIDATOR_H
+#define BACKGROUNDVALIDATOR_H
+
+#include "neuralnetwork.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Evaluates weight snapshots on a worker thread while training continues
+// on the live network, and tracks the best snapshot for early stopping.
+class BackgroundValidator
+{
+public:
+    // Scores a snapshot (e.g. accuracy on a held-out set); higher is better
+    using EvaluateFunction = std::function<double(NeuralNetwork&)>;
+
+    BackgroundValidator(EvaluateFunction evaluate, int patience, double minImprovement = 0.0);
+    ~BackgroundValidator();
+
+    BackgroundValidator(const BackgroundValidator&) = delete;
+    BackgroundValidator& operator=(const BackgroundValidator&) = delete;
+
+    // Copy the current weights and queue them for evaluation (never waits on the worker)
+    void submitSnapshot(const NeuralNetwork& network);
+
+    // Block until every submitted snapshot has been evaluated
+    void waitForIdle();
+
+    // True once `patience` consecutive evaluations failed to improve on the best score
+    bool shouldStop() const { return stopRequested.load(std::memory_order_acquire); }
+
+    // Copy the best evaluated snapshot into network; returns false if none evaluated yet
+    bool restoreBest(NeuralNetwork& network) const;
+
+    // Getters
+    double getBestScore() const;
+    int getBestSnapshotIndex() const;
+    int getEvaluatedCount() const;
+    int getSkippedCount() const;
+
+    // Snapshots whose evaluate callback threw; they never count toward best or patience
+    int getFailedCount() const;
+
+private:
+    void workerLoop();
+
+    EvaluateFunction evaluate;
+    int patience;
+    double minImprovement;
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeWorker;
+    std::condition_variable idle;
+
+    // Latest snapshot waiting for the worker; a newer submission replaces it
+    std::unique_ptr<NeuralNetwork> pending;
+    int pendingIndex = -1;
+    bool evaluating = false;
+    bool shuttingDown = false;
+
+    std::unique_ptr<NeuralNetwork> best;
+    double bestScore = 0.0;
+    int bestIndex = -1;
+    int submittedCount = 0;
+    int evaluatedCount = 0;
+    int failedCount = 0;
+    int skippedCount = 0;
+    int evaluationsWithoutImprovement = 0;
+    std::atomic<bool> stopRequested{false};
+
+    std::thread worker;
+};
+
+#endif // BACKGROUNDVALIDATOR_H
@@ -0,0 +1,353 @@
+#include "kernels.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace kernels {
+
+namespace {
+
+/**
+ * @brief Checks whether the running CPU (and OS) can execute a kernel variant
+ * __builtin_cpu_supports reads cpuid once at startup and also accounts for
+ * the OS enabling the wider register state.
+ */
+bool isSupported(const KernelTable* table) {
+#if defined(NERMAL_HAVE_AVX2_KERNELS)
+    if (table == &avx2::table) {
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }
+#endif
+#if defined(NERMAL_HAVE_AVX512_KERNELS)
+    if (table == &avx512::table) {
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") &&
+               __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512bw") &&
+               __builtin_cpu_supports("fma");
+    }
+#endif
+    return table == &generic::table;
+}
+
+// Every compiled-in variant, ordered from least to most capable
+std::vector<const KernelTable*> compiledTables() {
+    return {
+        &generic::table,
+#if defined(NERMAL_HAVE_AVX2_KERNELS)
+        &avx2::table,
+#endif
+#if defined(NERMAL_HAVE_AVX512_KERNELS)
+        &avx512::table,
+#endif
+    };
+}
+
+const KernelTable* findSupported(const std::string& name) {
+    for (const KernelTable* table : compiledTables()) {
+        if (name == table->name && isSupported(table)) {
+            return table;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Picks the initial kernel set: NERMAL_KERNEL if it names a usable
+ * variant, otherwise the most capable variant the CPU supports
+ */
+const KernelTable* detect() {
+    if (const char* requested = std::getenv("NERMAL_KERNEL")) {
+        if (const KernelTable* table = findSupported(requested)) {
+            return table;
+        }
+        std::cerr << "Warning: NERMAL_KERNEL=" << requested
+                  << " is not available on this CPU, using automatic selection" << std::endl;
+    }
+
+    const KernelTable* best = &generic::table;
+    for (const KernelTable* table : compiledTables()) {
+        if (isSupported(table)) {
+            best = table;
+        }
+    }
+    return best;
+}
+
+std::atomic<const KernelTable*>& current() {
+    static std::atomic<const KernelTable*> table{detect()};
+    return table;
+}
+
+// Hidden rows per block are rounded to a multiple of 8 doubles (one cache line)
+// to cut false sharing between neighbouring blocks. Block edges only land exactly
+// on line boundaries when the weight storage is 64-byte aligned and hiddenNodes
+// is a multiple of 8; Eigen's default allocation only guarantees 16 bytes, so
+// an edge may still share a line with the next block.
+constexpr int rowAlignment = 8;
+
+// Default size above which intra-op parallelism engages; below it the
+// handoff costs more than the split saves
+constexpr long long defaultIntraOpThreshold = 1LL << 18;
+
+int initialIntraOpThreads() {
+    if (const char* requested = std::getenv("NERMAL_INTRA_OP_THREADS")) {
+        return std::max(1, std::atoi(requested));
+    }
+    return 1;
+}
+
+std::atomic<int>& threadsSetting() {
+    static std::atomic<int> threads{initialIntraOpThreads()};
+    return threads;
+}
+
+std::atomic<long long>& thresholdSetting() {
+    static std::atomic<long long> threshold{defaultIntraOpThreshold};
+    return threshold;
+}
+
+// The pool in use is published through an atomic pointer so the hot path is a
+// single load. Replaced pools are retired, not destroyed, because a caller may
+// still be running on one; their idle workers sleep until the pool is reused.
+// There is at most one pool per thread count, so switching back and forth
+// between counts never creates more threads.
+std::atomic<SpinThreadPool*> currentPool{nullptr};
+std::mutex poolMutex;
+std::vector<std::unique_ptr<SpinThreadPool>> pools;
+
+/**
+ * @brief Returns the intra-op pool if this layer is wide enough to split, else null
+ * Takes poolMutex only when the thread count changed, to republish the pool of
+ * that size or create it on first use.
+ */
+SpinThreadPool* poolFor(int inputNodes, int hiddenNodes) {
+    int threads = threadsSetting().load(std::memory_order_relaxed);
+    if (threads <= 1 || hiddenNodes < 2 * rowAlignment ||
+        static_cast<long long>(inputNodes) * hiddenNodes < thresholdSetting().load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+
+    SpinThreadPool* pool = currentPool.load(std::memory_order_acquire);
+    if (pool && pool->size() == threads) {
+        return pool;
+    }
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    pool = currentPool.load(std::memory_order_acquire);
+    if (pool && pool->size() == threads) {
+        return pool;
+    }
+
+    auto match = std::find_if(pools.begin(), pools.end(),
+        [threads](const std::unique_ptr<SpinThreadPool>& candidate) { return candidate->size() == threads; });
+    if (match != pools.end()) {
+        pool = match->get();
+    } else {
+        pools.push_back(std::make_unique<SpinThreadPool>(threads));
+        pool = pools.back().get();
+    }
+    currentPool.store(pool, std::memory_order_release);
+    return pool;
+}
+
+/**
+ * @brief Runs step(begin, end) over the hidden rows, split into blocks across the pool
+ */
+template <typename Step>
+void forHiddenRows(SpinThreadPool* pool, int hiddenNodes, Step step) {
+    if (!pool) {
+        step(0, hiddenNodes);
+        return;
+    }
+
+    int rowsPerTask = (hiddenNodes + pool->size() - 1) / pool->size();
+    rowsPerTask = (rowsPerTask + rowAlignment - 1) / rowAlignment * rowAlignment;
+    int tasks = (hiddenNodes + rowsPerTask - 1) / rowsPerTask;
+
+    auto body = [&](int task) {
+        int begin = task * rowsPerTask;
+        step(begin, std::min(begin + rowsPerTask, hiddenNodes));
+    };
+    pool->parallelFor(tasks, body);
+}
+
+} // namespace
+
+const KernelTable& active() {
+    return *current().load(std::memory_order_acquire);
+}
+
+std::vector<std::string> available() {
+    std::vector<std::string> names;
+    for (const KernelTable* table : compiledTables()) {
+        if (isSupported(table)) {
+            names.push_back(table->name);
+        }
+    }
+    return names;
+}
+
+bool select(const std::string& name) {
+    const KernelTable* table = findSupported(name);
+    if (!table) {
+        return false;
+    }
+    current().store(table, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Forward pass; the input → hidden product is split by hidden rows when wide enough
+ */
+void query(const double* weightsInputToHidden, const double* weightsHiddenToOutput,
+           int inputNodes, int hiddenNodes, int outputNodes,
+           const double* inputs, double* outputs) {
+    const KernelTable& kernel = active();
+    SpinThreadPool* pool = poolFor(inputNodes, hiddenNodes);
+    std::vector<double> hiddenOutputs(hiddenNodes);
+
+    forHiddenRows(pool, hiddenNodes, [&](int begin, int end) {
+        kernel.hiddenForward(weightsInputToHidden, inputNodes, hiddenNodes, inputs,
+                             begin, end, hiddenOutputs.data());
+    });
+    kernel.outputForward(weightsHiddenToOutput, hiddenNodes, outputNodes, hiddenOutputs.data(), outputs);
+}
+
+/**
+ * @brief Forward pass on raw bytes, transformed inside the hidden layer kernel
+ */
+void query(const double* weightsInputToHidden, const double* weightsHiddenToOutput,
+           int inputNodes, int hiddenNodes, int outputNodes,
+           const uint8_t* rawInputs, double inputScale, double inputOffset,
+           const double* rowSums, double* outputs) {
+    const KernelTable& kernel = active();
+    SpinThreadPool* pool = poolFor(inputNodes, hiddenNodes);
+    std::vector<double> hiddenOutputs(hiddenNodes);
+
+    forHiddenRows(pool, hiddenNodes, [&](int begin, int end) {
+        kernel.hiddenForwardBytes(weightsInputToHidden, inputNodes, hiddenNodes,
+                                  rawInputs, inputScale, inputOffset, rowSums,
+                                  begin, end, hiddenOutputs.data());
+    });
+    kernel.outputForward(weightsHiddenToOutput, hiddenNodes, outputNodes, hiddenOutputs.data(), outputs);
+}
+
+namespace {
+
+/**
+ * @brief Shared skeleton of a backpropagation step
+ * The hidden layer forward pass and the backward pass with its weight updates
+ * are split by hidden rows; the (narrow) output layer runs on the caller in between.
+ * forward(begin, end, hiddenOutputs) and backward(begin, end, hiddenOutputs,
+ * outputErrors, outputGradients) supply the input-type specific hidden steps.
+ */
+template <typename Forward, typename Backward>
+void trainStep(const KernelTable& kernel, SpinThreadPool* pool,
+               const double* weightsHiddenToOutput, int hiddenNodes, int outputNodes,
+               const double* targets, Forward forward, Backward backward) {
+    std::vector<double> hiddenOutputs(hiddenNodes);
+    std::vector<double> finalOutputs(outputNodes);
+    std::vector<double> outputErrors(outputNodes);
+    std::vector<double> outputGradients(outputNodes);
+
+    // FORWARD PASS
+    forHiddenRows(pool, hiddenNodes, [&](int begin, int end) {
+        forward(begin, end, hiddenOutputs.data());
+    });
+    kernel.outputForward(weightsHiddenToOutput, hiddenNodes, outputNodes,
+                         hiddenOutputs.data(), finalOutputs.data());
+
+    // BACKPROPAGATION
+    kernel.outputBackward(outputNodes, targets, finalOutputs.data(),
+                          outputErrors.data(), outputGradients.data());
+    forHiddenRows(pool, hiddenNodes, [&](int begin, int end) {
+        backward(begin, end, hiddenOutputs.data(), outputErrors.data(), outputGradients.data());
+    });
+}
+
+} // namespace
+
+/**
+ * @brief One backpropagation step
+ */
+void train(double* weightsInputToHidden, double* weightsHiddenToOutput,
+           int inputNodes, int hiddenNodes, int outputNodes, double learningRate,
+           const double* inputs, double* rowSums, const double* targets) {
+    const KernelTable& kernel = active();
+    SpinThreadPool* pool = poolFor(inputNodes, hiddenNodes);
+
+    // Sum of the inputs, which is how far each row sum moves per unit gradient
+    double inputSum = 0.0;
+    if (rowSums) {
+        for (int j = 0; j < inputNodes; ++j) {
+            inputSum += inputs[j];
+        }
+    }
+
+    trainStep(kernel, pool, weightsHiddenToOutput, hiddenNodes, outputNodes, targets,
+        [&](int begin, int end, double* hiddenOutputs) {
+            kernel.hiddenForward(weightsInputToHidden, inputNodes, hiddenNodes, inputs,
+                                 begin, end, hiddenOutputs);
+        },
+        [&](int begin, int end, const double* hiddenOutputs,
+            const double* outputErrors, const double* outputGradients) {
+            kernel.hiddenBackward(weightsInputToHidden, weightsHiddenToOutput,
+                                  inputNodes, hiddenNodes, outputNodes, learningRate,
+                                  inputs, inputSum, rowSums, hiddenOutputs, outputErrors, outputGradients,
+                                  begin, end);
+        });
+}
+
+/**
+ * @brief One backpropagation step on raw bytes, transformed inside the hidden layer kernels
+ */
+void train(double* weightsInputToHidden, double* weightsHiddenToOutput,
+           int inputNodes, int hiddenNodes, int outputNodes, double learningRate,
+           const uint8_t* rawInputs, double inputScale, double inputOffset,
+           double* rowSums, const double* targets) {
+    const KernelTable& kernel = active();
+    SpinThreadPool* pool = poolFor(inputNodes, hiddenNodes);
+
+    // Sum of the transformed inputs, which is how far each row sum moves per unit gradient
+    long long rawSum = 0;
+    for (int j = 0; j < inputNodes; ++j) {
+        rawSum += rawInputs[j];
+    }
+    double inputSum = inputScale * static_cast<double>(rawSum) + inputOffset * inputNodes;
+
+    trainStep(kernel, pool, weightsHiddenToOutput, hiddenNodes, outputNodes, targets,
+        [&](int begin, int end, double* hiddenOutputs) {
+            kernel.hiddenForwardBytes(weightsInputToHidden, inputNodes, hiddenNodes,
+                                      rawInputs, inputScale, inputOffset, rowSums,
+                                      begin, end, hiddenOutputs);
+        },
+        [&](int begin, int end, const double* hiddenOutputs,
+            const double* outputErrors, const double* outputGradients) {
+            kernel.hiddenBackwardBytes(weightsInputToHidden, weightsHiddenToOutput,
+                                       inputNodes, hiddenNodes, outputNodes, learningRate,
+                                       rawInputs, inputScale, inputOffset, inputSum, rowSums,
+                                       hiddenOutputs, outputErrors, outputGradients,
+                                       begin, end);
+        });
+}
+
+void setIntraOpThreads(int threads) {
+    threadsSetting().store(std::max(1, threads), std::memory_order_relaxed);
+}
+
+int intraOpThreads() {
+    return threadsSetting().load(std::memory_order_relaxed);
+}
+
+void setIntraOpThreshold(long long minWeights) {
+    thresholdSetting().store(minWeights, std::memory_order_relaxed);
+}
+
+long long intraOpThreshold() {
+    return thresholdSetting().load(std::memory_order_relaxed);
+}
+
+} // namespace kernels
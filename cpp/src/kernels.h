@@ -0,0 +1,116 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Compute kernels for the forward pass and backpropagation. The same source
+// (kernels_impl.inl) is compiled once per instruction set level and the best
+// variant supported by the running CPU is picked at startup.
+//
+// This header must not pull in Eigen: each variant translation unit includes
+// Eigen under its own namespace name so the differently-compiled template
+// instantiations never get merged by the linker. Weight matrices are passed
+// as raw column-major storage.
+namespace kernels {
+
+// Building blocks of train/query. The hidden layer steps work on a range of
+// hidden rows [begin, end) so wide layers can be split across threads; rows
+// in different ranges touch disjoint weights and outputs.
+struct KernelTable {
+    const char* name;
+
+    // hiddenOutputs[begin, end) = sigmoid(weightsInputToHidden[begin, end) * inputs)
+    void (*hiddenForward)(const double* weightsInputToHidden, int inputNodes, int hiddenNodes,
+                          const double* inputs, int begin, int end, double* hiddenOutputs);
+
+    // outputs = sigmoid(weightsHiddenToOutput * hiddenOutputs)
+    void (*outputForward)(const double* weightsHiddenToOutput, int hiddenNodes, int outputNodes,
+                          const double* hiddenOutputs, double* outputs);
+
+    // Output errors and the gradients used to update weightsHiddenToOutput
+    void (*outputBackward)(int outputNodes, const double* targets, const double* outputs,
+                           double* outputErrors, double* outputGradients);
+
+    // Backpropagates into hidden rows [begin, end) and updates their weights:
+    // columns [begin, end) of weightsHiddenToOutput, rows [begin, end) of weightsInputToHidden.
+    // Also moves rowSums[begin, end) (if not null) along with the weights; inputSum is the sum of the inputs.
+    void (*hiddenBackward)(double* weightsInputToHidden, double* weightsHiddenToOutput,
+                           int inputNodes, int hiddenNodes, int outputNodes, double learningRate,
+                           const double* inputs, double inputSum, double* rowSums,
+                           const double* hiddenOutputs,
+                           const double* outputErrors, const double* outputGradients,
+                           int begin, int end);
+
+    // hiddenForward for raw byte inputs, where input = inputScale * raw + inputOffset.
+    // The transform is folded into the layer as inputScale * (W * raw) + inputOffset * rowSums,
+    // so no double input vector is built. rowSums holds the row sums of weightsInputToHidden
+    // and may be null when inputOffset is 0.
+    void (*hiddenForwardBytes)(const double* weightsInputToHidden, int inputNodes, int hiddenNodes,
+                               const uint8_t* rawInputs, double inputScale, double inputOffset,
+                               const double* rowSums, int begin, int end, double* hiddenOutputs);
+
+    // hiddenBackward for raw byte inputs. Also moves rowSums[begin, end) (if not null)
+    // along with the weights; inputSum is the sum of the transformed inputs.
+    void (*hiddenBackwardBytes)(double* weightsInputToHidden, double* weightsHiddenToOutput,
+                                int inputNodes, int hiddenNodes, int outputNodes, double learningRate,
+                                const uint8_t* rawInputs, double inputScale, double inputOffset, double inputSum,
+                                double* rowSums, const double* hiddenOutputs,
+                                const double* outputErrors, const double* outputGradients,
+                                int begin, int end);
+};
+
+namespace generic { extern const KernelTable table; }
+#ifdef NERMAL_HAVE_AVX2_KERNELS
+namespace avx2 { extern const KernelTable table; }
+#endif
+#ifdef NERMAL_HAVE_AVX512_KERNELS
+namespace avx512 { extern const KernelTable table; }
+#endif
+
+// Kernel set used by NeuralNetwork; chosen on first use from the CPU features,
+// or from the NERMAL_KERNEL environment variable when it names a usable variant
+const KernelTable& active();
+
+// Names of the compiled-in variants the running CPU can execute, best last
+std::vector<std::string> available();
+
+// Switch the active variant; returns false if it is unknown or unsupported
+bool select(const std::string& name);
+
+// Forward pass: writes outputNodes values to outputs
+void query(const double* weightsInputToHidden, const double* weightsHiddenToOutput,
+           int inputNodes, int hiddenNodes, int outputNodes,
+           const double* inputs, double* outputs);
+
+// One backpropagation step, updating both weight matrices in place; keeps
+// rowSums (the row sums of weightsInputToHidden, if not null) in step with the weights
+void train(double* weightsInputToHidden, double* weightsHiddenToOutput,
+           int inputNodes, int hiddenNodes, int outputNodes, double learningRate,
+           const double* inputs, double* rowSums, const double* targets);
+
+// Forward pass on raw bytes with input = inputScale * raw + inputOffset;
+// rowSums may be null when inputOffset is 0
+void query(const double* weightsInputToHidden, const double* weightsHiddenToOutput,
+           int inputNodes, int hiddenNodes, int outputNodes,
+           const uint8_t* rawInputs, double inputScale, double inputOffset,
+           const double* rowSums, double* outputs);
+
+// Backpropagation step on raw bytes; keeps rowSums (if not null) in step with the weights
+void train(double* weightsInputToHidden, double* weightsHiddenToOutput,
+           int inputNodes, int hiddenNodes, int outputNodes, double learningRate,
+           const uint8_t* rawInputs, double inputScale, double inputOffset,
+           double* rowSums, const double* targets);
+
+// Intra-op parallelism: query/train split the hidden layer into row blocks
+// across this many threads (1 = off, the default unless NERMAL_INTRA_OP_THREADS
+// is set) once the input-to-hidden matrix has at least the threshold weights
+void setIntraOpThreads(int threads);
+int intraOpThreads();
+void setIntraOpThreshold(long long minWeights);
+long long intraOpThreshold();
+
+} // namespace kernels
+
+#endif // KERNELS_H
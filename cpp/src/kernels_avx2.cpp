@@ -0,0 +1,7 @@
+// AVX2 + FMA kernels; CMake compiles this file with -mavx2 -mfma and then
+// renames its weak symbols (cmake/localize_kernel_symbols.cmake).
+#define Eigen nermal_eigen_avx2
+#define NERMAL_KERNEL_NAMESPACE avx2
+#define NERMAL_KERNEL_NAME "avx2"
+
+#include "kernels_impl.inl"
@@ -0,0 +1,7 @@
+// AVX-512 kernels; CMake compiles this file with -mavx512f -mavx512dq and friends
+// and then renames its weak symbols (cmake/localize_kernel_symbols.cmake).
+#define Eigen nermal_eigen_avx512
+#define NERMAL_KERNEL_NAMESPACE avx512
+#define NERMAL_KERNEL_NAME "avx512"
+
+#include "kernels_impl.inl"
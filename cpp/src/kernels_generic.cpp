@@ -0,0 +1,11 @@
+// Baseline kernels, built with the library's default compiler flags
+// (SSE2 on x86-64). Always present and used when nothing better is supported.
+#define Eigen nermal_eigen_generic
+#define NERMAL_KERNEL_NAMESPACE generic
+#if defined(__SSE2__)
+#define NERMAL_KERNEL_NAME "sse2"
+#else
+#define NERMAL_KERNEL_NAME "generic"
+#endif
+
+#include "kernels_impl.inl"
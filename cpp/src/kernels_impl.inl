@@ -0,0 +1,182 @@
+// Kernel bodies shared by every instruction set variant. Not compiled on its
+// own: each kernels_<isa>.cpp defines NERMAL_KERNEL_NAMESPACE, NERMAL_KERNEL_NAME
+// and a private name for the Eigen namespace, then includes this file with the
+// matching compiler flags.
+#if !defined(NERMAL_KERNEL_NAMESPACE) || !defined(NERMAL_KERNEL_NAME)
+#error "kernels_impl.inl must be included from a kernels_<isa>.cpp wrapper"
+#endif
+
+#include "kernels.h"
+#include <Eigen/Dense>
+#include <cmath>
+#include <cstdint>
+
+namespace kernels {
+namespace NERMAL_KERNEL_NAMESPACE {
+
+namespace {
+
+using Matrix = Eigen::Map<Eigen::MatrixXd>;
+using ConstMatrix = Eigen::Map<const Eigen::MatrixXd>;
+using ConstVector = Eigen::Map<const Eigen::VectorXd>;
+
+/**
+ * @brief Sigmoid activation applied element-wise: σ(x) = 1/(1 + e^(-x))
+ * Maps any real number to (0,1) range. Has useful derivative: σ'(x) = σ(x)(1-σ(x))
+ * which simplifies backpropagation calculations.
+ */
+Eigen::VectorXd sigmoid(const Eigen::VectorXd& values) {
+    return values.unaryExpr([](double x) { return 1.0 / (1.0 + std::exp(-x)); });
+}
+
+void hiddenForward(const double* weightsInputToHiddenData, int inputNodes, int hiddenNodes,
+                   const double* inputsData, int begin, int end, double* hiddenOutputsData) {
+    ConstMatrix weightsInputToHidden(weightsInputToHiddenData, hiddenNodes, inputNodes);
+    ConstVector inputs(inputsData, inputNodes);
+
+    // Each hidden node receives weighted sum of ALL input nodes
+    Eigen::Map<Eigen::VectorXd>(hiddenOutputsData + begin, end - begin) =
+        sigmoid(weightsInputToHidden.middleRows(begin, end - begin) * inputs);
+}
+
+void outputForward(const double* weightsHiddenToOutputData, int hiddenNodes, int outputNodes,
+                   const double* hiddenOutputsData, double* outputsData) {
+    ConstMatrix weightsHiddenToOutput(weightsHiddenToOutputData, outputNodes, hiddenNodes);
+    ConstVector hiddenOutputs(hiddenOutputsData, hiddenNodes);
+
+    // Each output node receives weighted sum of ALL hidden nodes
+    // TODO: consider replacing with softmax unless out is binary
+    Eigen::Map<Eigen::VectorXd>(outputsData, outputNodes) = sigmoid(weightsHiddenToOutput * hiddenOutputs);
+}
+
+void outputBackward(int outputNodes, const double* targetsData, const double* outputsData,
+                    double* outputErrorsData, double* outputGradientsData) {
+    ConstVector targets(targetsData, outputNodes);
+    ConstVector finalOutputs(outputsData, outputNodes);
+    Eigen::Map<Eigen::VectorXd> outputErrors(outputErrorsData, outputNodes);
+
+    // Output error: how far off are our predictions?
+    outputErrors = targets - finalOutputs;
+
+    // Gradient = error × sigmoid derivative σ(x)(1-σ(x))
+    Eigen::Map<Eigen::VectorXd>(outputGradientsData, outputNodes) =
+        outputErrors.array() * finalOutputs.array() * (1.0 - finalOutputs.array());
+}
+
+void hiddenForwardBytes(const double* weightsInputToHiddenData, int inputNodes, int hiddenNodes,
+                        const uint8_t* rawInputs, double inputScale, double inputOffset,
+                        const double* rowSumsData, int begin, int end, double* hiddenOutputsData) {
+    ConstMatrix weightsInputToHidden(weightsInputToHiddenData, hiddenNodes, inputNodes);
+    int rows = end - begin;
+
+    // W * (scale * raw + offset) = scale * (W * raw) + offset * rowSums(W)
+    // Bytes are widened one at a time as each weight column is accumulated,
+    // and zero inputs (most pixels of a digit image) skip their column entirely
+    Eigen::VectorXd weightedSum = Eigen::VectorXd::Zero(rows);
+    for (int j = 0; j < inputNodes; ++j) {
+        if (rawInputs[j] != 0) {
+            weightedSum.noalias() += static_cast<double>(rawInputs[j]) * weightsInputToHidden.col(j).segment(begin, rows);
+        }
+    }
+    weightedSum *= inputScale;
+    if (inputOffset != 0.0) {
+        weightedSum.noalias() += inputOffset * ConstVector(rowSumsData, hiddenNodes).segment(begin, rows);
+    }
+
+    Eigen::Map<Eigen::VectorXd>(hiddenOutputsData + begin, rows) = sigmoid(weightedSum);
+}
+
+/**
+ * @brief Backpropagates into hidden rows [begin, end) and updates the hidden → output weights
+ * @return Eigen::VectorXd Gradients for the input → hidden weights of those rows
+ */
+Eigen::VectorXd backpropagateToHidden(double* weightsHiddenToOutputData, int hiddenNodes, int outputNodes,
+                                      double learningRate, const double* hiddenOutputsData,
+                                      const double* outputErrorsData, const double* outputGradientsData,
+                                      int begin, int end) {
+    Matrix weightsHiddenToOutput(weightsHiddenToOutputData, outputNodes, hiddenNodes);
+    ConstVector outputErrors(outputErrorsData, outputNodes);
+    ConstVector outputGradients(outputGradientsData, outputNodes);
+
+    int rows = end - begin;
+    auto hiddenOutputs = ConstVector(hiddenOutputsData, hiddenNodes).segment(begin, rows);
+    auto hiddenToOutput = weightsHiddenToOutput.middleCols(begin, rows);
+
+    // Hidden error: distribute output errors back to hidden nodes, using the
+    // hidden → output weights from before this step's update
+    Eigen::VectorXd hiddenErrors = hiddenToOutput.transpose() * outputErrors;
+
+    // UPDATE WEIGHTS: Hidden → Output layer
+    // Adjust weights based on how much each hidden node contributed
+    hiddenToOutput.noalias() += learningRate * outputGradients * hiddenOutputs.transpose();
+
+    // Gradient = error × sigmoid derivative × input node activation (applied by the caller)
+    return hiddenErrors.array() * hiddenOutputs.array() * (1.0 - hiddenOutputs.array());
+}
+
+void hiddenBackward(double* weightsInputToHiddenData, double* weightsHiddenToOutputData,
+                    int inputNodes, int hiddenNodes, int outputNodes, double learningRate,
+                    const double* inputsData, double inputSum, double* rowSumsData,
+                    const double* hiddenOutputsData,
+                    const double* outputErrorsData, const double* outputGradientsData,
+                    int begin, int end) {
+    Matrix weightsInputToHidden(weightsInputToHiddenData, hiddenNodes, inputNodes);
+    ConstVector inputs(inputsData, inputNodes);
+    int rows = end - begin;
+
+    Eigen::VectorXd hiddenGradients = backpropagateToHidden(
+        weightsHiddenToOutputData, hiddenNodes, outputNodes, learningRate,
+        hiddenOutputsData, outputErrorsData, outputGradientsData, begin, end);
+
+    // UPDATE WEIGHTS: Input → Hidden layer
+    // If hiddenError > 0 (hidden node should have been MORE active): strengthen positive inputs
+    // If hiddenError < 0 (hidden node should have been LESS active): weaken positive inputs
+    weightsInputToHidden.middleRows(begin, rows).noalias() += learningRate * hiddenGradients * inputs.transpose();
+
+    // The row sums move by the update summed over all inputs
+    if (rowSumsData) {
+        Eigen::Map<Eigen::VectorXd>(rowSumsData, hiddenNodes).segment(begin, rows).noalias() +=
+            (learningRate * inputSum) * hiddenGradients;
+    }
+}
+
+void hiddenBackwardBytes(double* weightsInputToHiddenData, double* weightsHiddenToOutputData,
+                         int inputNodes, int hiddenNodes, int outputNodes, double learningRate,
+                         const uint8_t* rawInputs, double inputScale, double inputOffset, double inputSum,
+                         double* rowSumsData, const double* hiddenOutputsData,
+                         const double* outputErrorsData, const double* outputGradientsData,
+                         int begin, int end) {
+    Matrix weightsInputToHidden(weightsInputToHiddenData, hiddenNodes, inputNodes);
+    int rows = end - begin;
+
+    Eigen::VectorXd hiddenGradients = backpropagateToHidden(
+        weightsHiddenToOutputData, hiddenNodes, outputNodes, learningRate,
+        hiddenOutputsData, outputErrorsData, outputGradientsData, begin, end);
+
+    // UPDATE WEIGHTS: Input → Hidden layer, one column per input so each
+    // byte is transformed on the fly; inputs that map to 0 leave their column alone
+    for (int j = 0; j < inputNodes; ++j) {
+        double input = inputScale * rawInputs[j] + inputOffset;
+        if (input != 0.0) {
+            weightsInputToHidden.col(j).segment(begin, rows).noalias() += (learningRate * input) * hiddenGradients;
+        }
+    }
+
+    // The row sums move by the update summed over all inputs
+    if (rowSumsData) {
+        Eigen::Map<Eigen::VectorXd>(rowSumsData, hiddenNodes).segment(begin, rows).noalias() +=
+            (learningRate * inputSum) * hiddenGradients;
+    }
+}
+
+} // namespace
+
+// extern so the table is exported even if kernels.h doesn't declare this variant
+extern const KernelTable table = {
+    NERMAL_KERNEL_NAME,
+    hiddenForward, outputForward, outputBackward, hiddenBackward,
+    hiddenForwardBytes, hiddenBackwardBytes
+};
+
+} // namespace NERMAL_KERNEL_NAMESPACE
+} // namespace kernels
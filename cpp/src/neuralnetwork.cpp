@@ -1,4 +1,5 @@
 #include "neuralnetwork.h"
+#include "kernels.h"
 #include <random>
 #include <cmath>
 #include <algorithm>
@@ -15,7 +16,8 @@
  * @param learningRate Learning rate for training
  */
 NeuralNetwork::NeuralNetwork(int inputNodes, int hiddenNodes, int outputNodes, double learningRate)
-    : inputNodes(inputNodes), hiddenNodes(hiddenNodes), outputNodes(outputNodes), learningRate(learningRate)
+    : inputNodes(inputNodes), hiddenNodes(hiddenNodes), outputNodes(outputNodes), learningRate(learningRate),
+      inputScale(1.0), inputOffset(0.0)
 {
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -46,108 +48,147 @@ NeuralNetwork::NeuralNetwork(int inputNodes, int hiddenNodes, int outputNodes, d
 }
 
 /**
- * @brief Sigmoid activation function: σ(x) = 1/(1 + e^(-x))
- * Maps any real number to (0,1) range. Has useful derivative: σ'(x) = σ(x)(1-σ(x))
- * which simplifies backpropagation calculations.
+ * @brief Trains the neural network using backpropagation
+ * The forward pass, error propagation and weight updates run in the active
+ * compute kernel (see kernels_impl.inl), which works on the weight storage in place.
+ * Wide hidden layers are split into row blocks across the intra-op thread pool.
+ * Row sums cached for a non-zero input offset are updated in place with the weights.
+ * @param inputsList Input data vector
+ * @param targetsList Target output vector for supervised learning
  */
-double NeuralNetwork::sigmoid(double x) {
-    return 1.0 / (1.0 + std::exp(-x));
+void NeuralNetwork::train(const std::vector<double>& inputsList, const std::vector<double>& targetsList) {
+    kernels::train(weightsInputToHidden.data(), weightsHiddenToOutput.data(),
+                   inputNodes, hiddenNodes, outputNodes, learningRate,
+                   inputsList.data(), inputOffset != 0.0 ? inputRowSums.data() : nullptr,
+                   targetsList.data());
 }
 
 /**
- * @brief Matrix version of sigmoid function - applies sigmoid element-wise to entire matrix
- * Returns Eigen::MatrixXd because it processes multiple values at once (vectorized operation)
- * More efficient than calling scalar sigmoid in loops for neural network computations
+ * @brief Performs a forward pass through the network to get predictions
+ * @param inputsList Input data vector
+ * @return std::vector<double> Network output predictions
  */
-Eigen::MatrixXd NeuralNetwork::sigmoid(const Eigen::MatrixXd& matrix) {
-    return matrix.unaryExpr([](double x) { return 1.0 / (1.0 + std::exp(-x)); });
+std::vector<double> NeuralNetwork::query(const std::vector<double>& inputsList) {
+    std::vector<double> result(outputNodes);
+    kernels::query(weightsInputToHidden.data(), weightsHiddenToOutput.data(),
+                   inputNodes, hiddenNodes, outputNodes,
+                   inputsList.data(), result.data());
+    return result;
 }
 
 /**
- * @brief Trains the neural network using backpropagation
- * @param inputsList Input data vector
- * @param targetsList Target output vector for supervised learning
+ * @brief Declares the affine transform applied to raw uint8_t inputs
+ * For MNIST-style pixels, setInputTransform(0.99 / 255.0, 0.01) maps 0-255 to 0.01-1.0.
+ * @param scale Multiplier applied to each raw value
+ * @param offset Constant added after scaling
  */
-void NeuralNetwork::train(const std::vector<double>& inputsList, const std::vector<double>& targetsList) {
-    // Convert input data to column matrix for matrix operations
-    Eigen::MatrixXd inputs(inputNodes, 1);
-    for (int i = 0; i < inputNodes; ++i) {
-        inputs(i, 0) = inputsList[i];
-    }
-    
-    // Convert target data to column matrix
-    Eigen::MatrixXd targets(outputNodes, 1);
-    for (int i = 0; i < outputNodes; ++i) {
-        targets(i, 0) = targetsList[i];
-    }
-    
-    // FORWARD PASS: Input layer → Hidden layer
-    // Each hidden node receives weighted sum of ALL input nodes
-    Eigen::MatrixXd hiddenInputs = weightsInputToHidden * inputs;
-    Eigen::MatrixXd hiddenOutputs = sigmoid(hiddenInputs);  // Apply activation function
-    
-    // FORWARD PASS: Hidden layer → Output layer  
-    // Each output node receives weighted sum of ALL hidden nodes
-    Eigen::MatrixXd finalInputs = weightsHiddenToOutput * hiddenOutputs;
+void NeuralNetwork::setInputTransform(double scale, double offset) {
+    inputScale = scale;
+    inputOffset = offset;
+    rebuildInputRowSums();
+}
 
+/**
+ * @brief Recomputes the row sums of weightsInputToHidden used to fold in inputOffset
+ * W * (scale * raw + offset) = scale * (W * raw) + offset * rowSums(W), so the
+ * offset costs one precomputed vector instead of a pass over every input.
+ * Training updates the sums in place along with the weights; a full rebuild
+ * is only needed when the weights are replaced (deserialization) or a new
+ * transform is set, so queryBytes() only ever reads them. With a zero offset
+ * the sums are unused and not maintained; they are dropped and rebuilt when
+ * an offset is set again.
+ */
+void NeuralNetwork::rebuildInputRowSums() {
+    if (inputOffset == 0.0) {
+        inputRowSums.resize(0);
+        return;
+    }
+    inputRowSums = weightsInputToHidden.rowwise().sum();
+}
 
-    // TODO: consider replacing with softmax unless out is binary
-    Eigen::MatrixXd finalOutputs = sigmoid(finalInputs);   // Final predictions
-    
-    // BACKPROPAGATION: Calculate errors working backwards
-    // Output error: how far off are our predictions?
-    Eigen::MatrixXd outputErrors = targets - finalOutputs;
-    
-    // Hidden error: distribute output errors back to hidden nodes
-    // Each hidden node's error depends on how much it contributed to output errors
-    Eigen::MatrixXd hiddenErrors = weightsHiddenToOutput.transpose() * outputErrors;
-    
-    // UPDATE WEIGHTS: Hidden → Output layer
-    // Gradient = error × sigmoid derivative × hidden node activation
-    Eigen::MatrixXd outputGradients = outputErrors.cwiseProduct(finalOutputs).cwiseProduct(
-        finalOutputs.unaryExpr([](double x) { return 1.0 - x; })  // Sigmoid derivative: σ(x)(1-σ(x))
-    );
-    // Adjust weights based on how much each hidden node contributed
-    weightsHiddenToOutput += learningRate * outputGradients * hiddenOutputs.transpose();
-    
-    // UPDATE WEIGHTS: Input → Hidden layer
-    // Gradient = error × sigmoid derivative × input node activation
-    Eigen::MatrixXd hiddenGradients = hiddenErrors.cwiseProduct(hiddenOutputs).cwiseProduct(
-        hiddenOutputs.unaryExpr([](double x) { return 1.0 - x; })  // Sigmoid derivative
-    );
-    // Weight update logic: "increase connection" means make weight more positive/less negative
-    // If hiddenError > 0 (hidden node should have been MORE active): strengthen positive inputs
-    // If hiddenError < 0 (hidden node should have been LESS active): weaken positive inputs
-    // The direction depends on BOTH the error sign AND input value sign
-    // inputs.transpose() creates matrix where each column represents input activation levels
-    weightsInputToHidden += learningRate * hiddenGradients * inputs.transpose();
+/**
+ * @brief Trains the network on raw uint8_t inputs
+ * Each byte is transformed by the input transform inside the kernel, so no
+ * double input vector is materialized. The row sums are updated in place
+ * along with the weights.
+ * @param inputsList Raw input values (e.g. 0-255 pixels)
+ * @param targetsList Target output vector for supervised learning
+ */
+void NeuralNetwork::trainBytes(const std::vector<uint8_t>& inputsList, const std::vector<double>& targetsList) {
+    kernels::train(weightsInputToHidden.data(), weightsHiddenToOutput.data(),
+                   inputNodes, hiddenNodes, outputNodes, learningRate,
+                   inputsList.data(), inputScale, inputOffset,
+                   inputOffset != 0.0 ? inputRowSums.data() : nullptr,
+                   targetsList.data());
 }
 
 /**
- * @brief Performs a forward pass through the network to get predictions
- * @param inputsList Input data vector
+ * @brief Performs a forward pass on raw uint8_t inputs
+ * Only reads the network, so concurrent queries on a shared model are safe.
+ * @param inputsList Raw input values (e.g. 0-255 pixels)
  * @return std::vector<double> Network output predictions
  */
-std::vector<double> NeuralNetwork::query(const std::vector<double>& inputsList) {
-    Eigen::MatrixXd inputs(inputNodes, 1);
-    for (int i = 0; i < inputNodes; ++i) {
-        inputs(i, 0) = inputsList[i];
-    }
-    
-    Eigen::MatrixXd hiddenInputs = weightsInputToHidden * inputs;
-    Eigen::MatrixXd hiddenOutputs = sigmoid(hiddenInputs);
-    
-    Eigen::MatrixXd finalInputs = weightsHiddenToOutput * hiddenOutputs;
-    Eigen::MatrixXd finalOutputs = sigmoid(finalInputs);
-    
+std::vector<double> NeuralNetwork::queryBytes(const std::vector<uint8_t>& inputsList) {
     std::vector<double> result(outputNodes);
-    for (int i = 0; i < outputNodes; ++i) {
-        result[i] = finalOutputs(i, 0);
-    }
-    
+    kernels::query(weightsInputToHidden.data(), weightsHiddenToOutput.data(),
+                   inputNodes, hiddenNodes, outputNodes,
+                   inputsList.data(), inputScale, inputOffset,
+                   inputOffset != 0.0 ? inputRowSums.data() : nullptr,
+                   result.data());
     return result;
 }
 
+/**
+ * @brief Lists the compute kernel variants the running CPU can execute
+ * @return std::vector<std::string> Variant names, least to most capable
+ */
+std::vector<std::string> NeuralNetwork::availableKernels() {
+    return kernels::available();
+}
+
+/**
+ * @brief Returns the compute kernel variant used by train/query
+ * Chosen on first use from cpuid, or from the NERMAL_KERNEL environment variable
+ */
+std::string NeuralNetwork::activeKernel() {
+    return kernels::active().name;
+}
+
+/**
+ * @brief Overrides the compute kernel variant for all networks in the process
+ * @param name Variant name as reported by availableKernels()
+ * @return bool True if the variant is available and now active
+ */
+bool NeuralNetwork::selectKernel(const std::string& name) {
+    return kernels::select(name);
+}
+
+/**
+ * @brief Sets how many threads split a single train/query call by hidden rows
+ * Independent of any parallelism the caller uses across samples. Only engages
+ * for layers with at least getIntraOpThreshold() input-to-hidden weights.
+ * @param threads Threads per call including the caller; 1 disables the split
+ */
+void NeuralNetwork::setIntraOpThreads(int threads) {
+    kernels::setIntraOpThreads(threads);
+}
+
+int NeuralNetwork::getIntraOpThreads() {
+    return kernels::intraOpThreads();
+}
+
+/**
+ * @brief Sets the input-to-hidden weight count (inputs x hidden nodes) above which calls are split
+ * @param minWeights Minimum matrix size to engage intra-op parallelism
+ */
+void NeuralNetwork::setIntraOpThreshold(long long minWeights) {
+    kernels::setIntraOpThreshold(minWeights);
+}
+
+long long NeuralNetwork::getIntraOpThreshold() {
+    return kernels::intraOpThreshold();
+}
+
 /**
  * @brief Prints detailed information about the neural network structure
  */
@@ -272,8 +313,10 @@ bool NeuralNetwork::deserializeFromBytes(const std::vector<uint8_t>& data) {
             return false;
         }
         
-        // Update learning rate
-        learningRate = newLearningRate;
+        // Weights are read into temporaries and only committed once the whole
+        // payload is valid, so a failed load leaves the network untouched
+        Eigen::MatrixXd newWeightsInputToHidden(hiddenNodes, inputNodes);
+        Eigen::MatrixXd newWeightsHiddenToOutput(outputNodes, hiddenNodes);
         
         // Read input-to-hidden weights
         int rows, cols;
@@ -294,7 +337,7 @@ bool NeuralNetwork::deserializeFromBytes(const std::vector<uint8_t>& data) {
                     std::cerr << "Error: Failed to read input-to-hidden weights" << std::endl;
                     return false;
                 }
-                weightsInputToHidden(i, j) = weight;
+                newWeightsInputToHidden(i, j) = weight;
             }
         }
         
@@ -316,10 +359,15 @@ bool NeuralNetwork::deserializeFromBytes(const std::vector<uint8_t>& data) {
                     std::cerr << "Error: Failed to read hidden-to-output weights" << std::endl;
                     return false;
                 }
-                weightsHiddenToOutput(i, j) = weight;
+                newWeightsHiddenToOutput(i, j) = weight;
             }
         }
         
+        learningRate = newLearningRate;
+        weightsInputToHidden = std::move(newWeightsInputToHidden);
+        weightsHiddenToOutput = std::move(newWeightsHiddenToOutput);
+        rebuildInputRowSums();
+        
         std::cout << "Neural network deserialized successfully from " << data.size() << " bytes" << std::endl;
         return true;
         
@@ -6,6 +6,7 @@
 #include <iostream>
 #include <memory>
 #include <cstdint>
+#include <string>
 
 class NeuralNetwork
 {
@@ -19,12 +20,20 @@ private:
     Eigen::MatrixXd weightsInputToHidden;
     Eigen::MatrixXd weightsHiddenToOutput;
 
-    // Sigmoid activation function
-    static double sigmoid(double x);
-    static Eigen::MatrixXd sigmoid(const Eigen::MatrixXd& matrix);
+    // Affine transform for raw uint8_t inputs: input = inputScale * raw + inputOffset
+    double inputScale;
+    double inputOffset;
+
+    // Row sums of weightsInputToHidden, the precomputed bias term that folds
+    // inputOffset into the first layer; kept current whenever inputOffset != 0
+    Eigen::VectorXd inputRowSums;
+
+    void rebuildInputRowSums();
+
+    // Sigmoid activation and the train/query math live in the per-ISA compute
+    // kernels (kernels_impl.inl), selected at runtime from the CPU features
 
     // TODO: implement a simple softmax function
-    // static Eigen::MatrixXd softmax(const Eigen::MatrixXd& matrix);
 
 public:
     NeuralNetwork(int inputNodes, int hiddenNodes, int outputNodes, double learningRate);
@@ -35,6 +44,13 @@ public:
     // Query the network (forward pass)
     std::vector<double> query(const std::vector<double>& inputsList);
 
+    // Declare how raw uint8_t inputs map to network inputs: input = scale * raw + offset
+    void setInputTransform(double scale, double offset);
+
+    // Train/query on raw uint8_t inputs (e.g. pixels), transformed inside the kernel
+    void trainBytes(const std::vector<uint8_t>& inputsList, const std::vector<double>& targetsList);
+    std::vector<double> queryBytes(const std::vector<uint8_t>& inputsList);
+
     // Serialize network data to binary format
     std::vector<uint8_t> serializeToBytes() const;
 
@@ -49,6 +65,24 @@ public:
     int getHiddenNodes() const { return hiddenNodes; }
     int getOutputNodes() const { return outputNodes; }
     double getLearningRate() const { return learningRate; }
+    double getInputScale() const { return inputScale; }
+    double getInputOffset() const { return inputOffset; }
+
+    // Compute kernel variants (e.g. "sse2", "avx2", "avx512") usable on this CPU
+    static std::vector<std::string> availableKernels();
+
+    // Name of the kernel variant currently used by train/query
+    static std::string activeKernel();
+
+    // Force a kernel variant for all networks; returns false if it is not available
+    static bool selectKernel(const std::string& name);
+
+    // Threads that split one train/query call by hidden rows (1 = off; default
+    // from NERMAL_INTRA_OP_THREADS), used once inputs x hidden >= the threshold
+    static void setIntraOpThreads(int threads);
+    static int getIntraOpThreads();
+    static void setIntraOpThreshold(long long minWeights);
+    static long long getIntraOpThreshold();
 };
 
 #endif // NEURALNETWORK_H
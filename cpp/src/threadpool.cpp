@@ -0,0 +1,136 @@
+#include "threadpool.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Pause iterations before a waiting thread starts yielding its time slice,
+// so an oversubscribed machine still lets the thread being waited on run
+constexpr int spinIterationsBeforeYield = 1 << 10;
+
+// Wait iterations a worker spins/yields for before going to sleep
+constexpr int spinIterationsBeforeSleep = 1 << 14;
+
+/**
+ * @brief Tells the CPU we are in a spin-wait loop (saves power, frees the sibling hyperthread)
+ */
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+/**
+ * @brief One step of a spin-wait: pause at first, then yield once the wait drags on
+ */
+inline void backoff(int& spins) {
+    if (++spins < spinIterationsBeforeYield) {
+        cpuRelax();
+    } else {
+        std::this_thread::yield();
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Starts threads - 1 persistent workers
+ * @param threads Total number of threads working on a job, including the caller
+ */
+SpinThreadPool::SpinThreadPool(int threads) {
+    for (int i = 1; i < threads; ++i) {
+        workers.emplace_back(&SpinThreadPool::workerLoop, this);
+    }
+}
+
+SpinThreadPool::~SpinThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping.store(true);
+    }
+    wakeWorkers.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Publishes a job to the workers, helps run it, and spins until all workers are done
+ */
+void SpinThreadPool::run(int tasks, TaskFunction function, void* context) {
+    std::unique_lock<std::mutex> caller(callerMutex, std::try_to_lock);
+    if (!caller.owns_lock() || workers.empty()) {
+        for (int task = 0; task < tasks; ++task) {
+            function(context, task);
+        }
+        return;
+    }
+
+    jobFunction = function;
+    jobContext = context;
+    jobTasks = tasks;
+    nextTask.store(0, std::memory_order_relaxed);
+    activeWorkers.store(static_cast<int>(workers.size()), std::memory_order_relaxed);
+
+    // Publishing the generation releases the job fields above to the workers.
+    // Sequentially consistent so that either we see a sleeper here or the
+    // sleeper sees the new generation before it waits.
+    generation.fetch_add(1);
+    if (sleepingWorkers.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wakeWorkers.notify_all();
+    }
+
+    runTasks();
+
+    // Workers must be out of this job before its fields can be reused
+    int spins = 0;
+    while (activeWorkers.load(std::memory_order_acquire) != 0) {
+        backoff(spins);
+    }
+}
+
+/**
+ * @brief Claims and runs tasks of the current job until none are left
+ */
+void SpinThreadPool::runTasks() {
+    int task;
+    while ((task = nextTask.fetch_add(1, std::memory_order_relaxed)) < jobTasks) {
+        jobFunction(jobContext, task);
+    }
+}
+
+/**
+ * @brief Worker thread: spin for the next generation, run its tasks, report done
+ */
+void SpinThreadPool::workerLoop() {
+    // Jobs may be published before this thread first runs, so start from the
+    // generation the pool was created with rather than the current one
+    uint64_t seen = 0;
+    while (true) {
+        int spins = 0;
+        while (generation.load(std::memory_order_acquire) == seen) {
+            if (stopping.load(std::memory_order_relaxed)) {
+                return;
+            }
+            if (spins < spinIterationsBeforeSleep) {
+                backoff(spins);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepingWorkers.fetch_add(1);
+            wakeWorkers.wait(lock, [&] { return generation.load() != seen || stopping.load(); });
+            sleepingWorkers.fetch_sub(1);
+            spins = 0;
+        }
+        seen = generation.load(std::memory_order_acquire);
+
+        runTasks();
+        activeWorkers.fetch_sub(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker pool for splitting a single train/query call across
+// threads. Workers spin on a generation counter between jobs so handing
+// off back-to-back jobs costs no kernel wake-up; after spinning for a
+// while without work they fall back to sleeping on a condition variable.
+class SpinThreadPool
+{
+public:
+    // threads counts the calling thread, so threads - 1 workers are started
+    explicit SpinThreadPool(int threads);
+    ~SpinThreadPool();
+
+    SpinThreadPool(const SpinThreadPool&) = delete;
+    SpinThreadPool& operator=(const SpinThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+
+    // Run body(task) for task in [0, tasks) on the pool and the calling thread,
+    // returning once every task is done. If another thread is already using the
+    // pool, the tasks run serially on the caller instead of waiting.
+    template <typename Body>
+    void parallelFor(int tasks, Body& body) {
+        run(tasks, [](void* context, int task) { (*static_cast<Body*>(context))(task); }, &body);
+    }
+
+private:
+    using TaskFunction = void (*)(void* context, int task);
+
+    void run(int tasks, TaskFunction function, void* context);
+    void runTasks();
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+
+    // Current job; written by the caller before publishing a new generation
+    TaskFunction jobFunction = nullptr;
+    void* jobContext = nullptr;
+    int jobTasks = 0;
+
+    alignas(64) std::atomic<uint64_t> generation{0};
+    alignas(64) std::atomic<int> nextTask{0};
+    alignas(64) std::atomic<int> activeWorkers{0};
+    alignas(64) std::atomic<int> sleepingWorkers{0};
+    std::atomic<bool> stopping{false};
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeWorkers;
+
+    // Only one caller may drive the pool at a time
+    std::mutex callerMutex;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,124 @@
+#include "neuralnetwork.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+
+// Times query and train for each compute kernel variant usable on this CPU.
+// Usage: kernel_benchmark [iterations] [hiddenNodes] [intraOpThreads]
+int main(int argc, char** argv) {
+    int iterations = (argc > 1) ? std::atoi(argv[1]) : 2000;
+    int inputNodes = 784;
+    int hiddenNodes = (argc > 2) ? std::atoi(argv[2]) : 200;
+    int outputNodes = 10;
+    if (argc > 3) {
+        NeuralNetwork::setIntraOpThreads(std::atoi(argv[3]));
+    }
+
+    std::cout << "=== Kernel Benchmark ===" << std::endl;
+    std::cout << "Network: " << inputNodes << "x" << hiddenNodes << "x" << outputNodes
+              << ", " << iterations << " iterations" << std::endl;
+    std::cout << "Intra-op threads: " << NeuralNetwork::getIntraOpThreads()
+              << " (threshold " << NeuralNetwork::getIntraOpThreshold() << " weights)" << std::endl;
+    std::cout << "Auto-selected kernel: " << NeuralNetwork::activeKernel() << std::endl;
+
+    // Shared samples so every variant sees identical work
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> pixel(0.01, 1.0);
+    std::vector<std::vector<double>> inputs(16, std::vector<double>(inputNodes));
+    for (auto& sample : inputs) {
+        for (auto& value : sample) {
+            value = pixel(gen);
+        }
+    }
+    // Raw pixel samples for the uint8_t path, mostly zero like MNIST digits
+    std::uniform_int_distribution<int> rawPixel(0, 255);
+    std::vector<std::vector<uint8_t>> rawInputs(16, std::vector<uint8_t>(inputNodes));
+    for (auto& sample : rawInputs) {
+        for (auto& value : sample) {
+            value = (rawPixel(gen) < 50) ? static_cast<uint8_t>(rawPixel(gen)) : 0;
+        }
+    }
+    std::vector<double> targets(outputNodes, 0.01);
+    targets[3] = 0.99;
+
+    NeuralNetwork reference(inputNodes, hiddenNodes, outputNodes, 0.1);
+    reference.setInputTransform(0.99 / 255.0, 0.01);
+    std::vector<double> baselineOutput;
+    std::vector<double> baselineByteOutput;
+    double worstDifference = 0.0;
+
+    std::cout << std::left << std::setw(10) << "kernel"
+              << std::right << std::setw(14) << "query (us)"
+              << std::setw(14) << "train (us)"
+              << std::setw(16) << "query u8 (us)"
+              << std::setw(16) << "train u8 (us)" << std::endl;
+
+    for (const auto& name : NeuralNetwork::availableKernels()) {
+        NeuralNetwork::selectKernel(name);
+        NeuralNetwork network = reference;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        double checksum = 0.0;
+        for (int i = 0; i < iterations; i++) {
+            checksum += network.query(inputs[i % inputs.size()])[0];
+        }
+        auto queryTime = std::chrono::duration<double, std::micro>(
+            std::chrono::high_resolution_clock::now() - start).count() / iterations;
+
+        start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            network.train(inputs[i % inputs.size()], targets);
+        }
+        auto trainTime = std::chrono::duration<double, std::micro>(
+            std::chrono::high_resolution_clock::now() - start).count() / iterations;
+
+        start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            checksum += network.queryBytes(rawInputs[i % rawInputs.size()])[0];
+        }
+        auto byteQueryTime = std::chrono::duration<double, std::micro>(
+            std::chrono::high_resolution_clock::now() - start).count() / iterations;
+
+        NeuralNetwork byteNetwork = reference;
+        start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            byteNetwork.trainBytes(rawInputs[i % rawInputs.size()], targets);
+        }
+        auto byteTrainTime = std::chrono::duration<double, std::micro>(
+            std::chrono::high_resolution_clock::now() - start).count() / iterations;
+
+        // Every variant must reproduce the baseline's results up to rounding
+        auto output = network.query(inputs[0]);
+        auto byteOutput = byteNetwork.queryBytes(rawInputs[0]);
+        if (baselineOutput.empty()) {
+            baselineOutput = output;
+            baselineByteOutput = byteOutput;
+        }
+        for (size_t i = 0; i < output.size(); i++) {
+            worstDifference = std::max(worstDifference, std::abs(output[i] - baselineOutput[i]));
+            worstDifference = std::max(worstDifference, std::abs(byteOutput[i] - baselineByteOutput[i]));
+        }
+
+        std::cout << std::left << std::setw(10) << name
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(14) << queryTime
+                  << std::setw(14) << trainTime
+                  << std::setw(16) << byteQueryTime
+                  << std::setw(16) << byteTrainTime
+                  << "  (checksum " << checksum << ")" << std::endl;
+    }
+
+    std::cout << "Max output difference vs baseline: " << std::scientific << worstDifference << std::endl;
+    if (worstDifference > 1e-9) {
+        std::cerr << "Kernel variants disagree" << std::endl;
+        return 1;
+    }
+    std::cout << "All kernel variants agree" << std::endl;
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include "neuralnetwork.h"
+#include "backgroundvalidator.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -7,6 +8,7 @@
 #include <chrono>
 #include <random>
 #include <algorithm>
+#include <cstdint>
 
 // Helper function to split CSV line
 std::vector<std::string> split(const std::string& line, char delimiter) {
@@ -19,18 +21,18 @@ std::vector<std::string> split(const std::string& line, char delimiter) {
     return tokens;
 }
 
-// Helper function to normalize pixel values (0-255 to 0.01-0.99)
-std::vector<double> normalizePixels(const std::vector<std::string>& pixelStrings) {
-    std::vector<double> normalized;
-    normalized.reserve(pixelStrings.size());
+// Helper function to parse raw pixel values (0-255). Normalization to 0.01-0.99
+// (matching Python implementation) is declared on the network via setInputTransform
+// and applied inside the kernels, so samples stay 784 bytes instead of 784 doubles.
+std::vector<uint8_t> parsePixels(const std::vector<std::string>& pixelStrings) {
+    std::vector<uint8_t> pixels;
+    pixels.reserve(pixelStrings.size());
     
     for (const auto& pixel : pixelStrings) {
-        double value = std::stod(pixel);
-        // Normalize from 0-255 to 0.01-0.99 (matching Python implementation)
-        normalized.push_back((value / 255.0 * 0.99) + 0.01);
+        pixels.push_back(static_cast<uint8_t>(std::stoi(pixel)));
     }
     
-    return normalized;
+    return pixels;
 }
 
 // Helper function to create target vector
@@ -41,8 +43,8 @@ std::vector<double> createTargets(int label, int outputNodes) {
 }
 
 // Function to load and process training data
-std::vector<std::pair<std::vector<double>, std::vector<double>>> loadTrainingData(const std::string& filename, int maxSamples = -1) {
-    std::vector<std::pair<std::vector<double>, std::vector<double>>> trainingData;
+std::vector<std::pair<std::vector<uint8_t>, std::vector<double>>> loadTrainingData(const std::string& filename, int maxSamples = -1) {
+    std::vector<std::pair<std::vector<uint8_t>, std::vector<double>>> trainingData;
     std::ifstream file(filename);
     std::string line;
     
@@ -62,7 +64,7 @@ std::vector<std::pair<std::vector<double>, std::vector<double>>> loadTrainingDat
         int label = std::stoi(tokens[0]);
         std::vector<std::string> pixelStrings(tokens.begin() + 1, tokens.end());
         
-        auto inputs = normalizePixels(pixelStrings);
+        auto inputs = parsePixels(pixelStrings);
         auto targets = createTargets(label, 10);
         
         trainingData.emplace_back(inputs, targets);
@@ -74,9 +76,10 @@ std::vector<std::pair<std::vector<double>, std::vector<double>>> loadTrainingDat
     return trainingData;
 }
 
-// Function to load test data
-std::vector<std::pair<std::vector<double>, int>> loadTestData(const std::string& filename, int maxSamples = -1) {
-    std::vector<std::pair<std::vector<double>, int>> testData;
+// Function to load test data, optionally skipping the first `skipSamples` rows
+// (used to hold out validation rows that follow the training samples)
+std::vector<std::pair<std::vector<uint8_t>, int>> loadTestData(const std::string& filename, int maxSamples = -1, int skipSamples = 0) {
+    std::vector<std::pair<std::vector<uint8_t>, int>> testData;
     std::ifstream file(filename);
     std::string line;
     
@@ -85,6 +88,11 @@ std::vector<std::pair<std::vector<double>, int>> loadTestData(const std::string&
         return testData;
     }
     
+    int skipped = 0;
+    while (skipped < skipSamples && std::getline(file, line)) {
+        skipped++;
+    }
+    
     int count = 0;
     while (std::getline(file, line) && (maxSamples == -1 || count < maxSamples)) {
         auto tokens = split(line, ',');
@@ -96,7 +104,7 @@ std::vector<std::pair<std::vector<double>, int>> loadTestData(const std::string&
         int label = std::stoi(tokens[0]);
         std::vector<std::string> pixelStrings(tokens.begin() + 1, tokens.end());
         
-        auto inputs = normalizePixels(pixelStrings);
+        auto inputs = parsePixels(pixelStrings);
         
         testData.emplace_back(inputs, label);
         count++;
@@ -108,7 +116,7 @@ std::vector<std::pair<std::vector<double>, int>> loadTestData(const std::string&
 }
 
 // Function to test the network accuracy
-double testNetworkAccuracy(NeuralNetwork& network, const std::vector<std::pair<std::vector<double>, int>>& testData, int maxSamples = -1) {
+double testNetworkAccuracy(NeuralNetwork& network, const std::vector<std::pair<std::vector<uint8_t>, int>>& testData, int maxSamples = -1) {
     int correct = 0;
     int total = 0;
     
@@ -116,7 +124,7 @@ double testNetworkAccuracy(NeuralNetwork& network, const std::vector<std::pair<s
     
     for (int i = 0; i < limit; i++) {
         const auto& sample = testData[i];
-        auto result = network.query(sample.first);
+        auto result = network.queryBytes(sample.first);
         
         // Find the index of the maximum output (predicted digit)
         int predicted = std::max_element(result.begin(), result.end()) - result.begin();
@@ -142,18 +150,25 @@ int main() {
     // Determine sample sizes based on build configuration
 #ifdef QUICK_TEST
     int trainingSamples = 100;
+    int validationSamples = 20;
     int testSamples = 20;
-    int epochs = 2;
+    int maxEpochs = 2;
     std::cout << "Running QUICK TEST mode" << std::endl;
 #else
     int trainingSamples = 1000;
+    int validationSamples = 200;
     int testSamples = 100;
-    int epochs = 5;
+    int maxEpochs = 10;
     std::cout << "Running FULL TEST mode" << std::endl;
 #endif
+    // Stop after this many validation passes without improvement
+    int patience = 3;
+    // Snapshot the weights for validation this many times per epoch
+    int snapshotsPerEpoch = 2;
     
     // Create neural network
     NeuralNetwork nermal(inputNodes, hiddenNodes, outputNodes, learningRate);
+    nermal.setInputTransform(0.99 / 255.0, 0.01);  // pixel / 255 * 0.99 + 0.01
     nermal.printNetworkInfo();
     
     // Load training data
@@ -165,12 +180,21 @@ int main() {
         return 1;
     }
     
+    // Held-out validation set, taken from the rows after the training samples
+    auto validationData = loadTestData("csv/mnist_train.csv", validationSamples, trainingSamples);
+    
+    // Snapshots are scored on a worker thread while training continues
+    BackgroundValidator validator([&validationData](NeuralNetwork& snapshot) {
+        return testNetworkAccuracy(snapshot, validationData);
+    }, patience);
+    
     // Train the network
     std::cout << "\n=== Training Network ===" << std::endl;
     auto startTime = std::chrono::high_resolution_clock::now();
     
-    for (int epoch = 0; epoch < epochs; epoch++) {
-        std::cout << "Epoch " << (epoch + 1) << "/" << epochs << ": ";
+    int snapshotInterval = std::max(1, (int)trainingData.size() / snapshotsPerEpoch);
+    for (int epoch = 0; epoch < maxEpochs && !validator.shouldStop(); epoch++) {
+        std::cout << "Epoch " << (epoch + 1) << "/" << maxEpochs << ": ";
         std::cout.flush();
         
         // Shuffle training data
@@ -178,8 +202,11 @@ int main() {
         std::mt19937 g(rd());
         std::shuffle(trainingData.begin(), trainingData.end(), g);
         
-        for (const auto& sample : trainingData) {
-            nermal.train(sample.first, sample.second);
+        for (size_t i = 0; i < trainingData.size(); i++) {
+            nermal.trainBytes(trainingData[i].first, trainingData[i].second);
+            if (!validationData.empty() && (i + 1) % snapshotInterval == 0) {
+                validator.submitSnapshot(nermal);
+            }
         }
         
         std::cout << "Complete" << std::endl;
@@ -189,6 +216,18 @@ int main() {
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
     std::cout << "Training completed in " << duration.count() << " ms" << std::endl;
     
+    // Roll back to the best validated weights
+    validator.waitForIdle();
+    if (validator.shouldStop()) {
+        std::cout << "Early stopping: no improvement in " << patience << " validation passes" << std::endl;
+    }
+    if (validator.restoreBest(nermal)) {
+        std::cout << "Restored snapshot " << (validator.getBestSnapshotIndex() + 1)
+                  << " (validation accuracy " << (validator.getBestScore() * 100) << "%, "
+                  << validator.getEvaluatedCount() << " evaluated, "
+                  << validator.getSkippedCount() << " skipped)" << std::endl;
+    }
+    
     // Load test data
     std::cout << "\n=== Loading Test Data ===" << std::endl;
     auto testData = loadTestData("csv/mnist_test.csv", testSamples);
@@ -208,7 +247,7 @@ int main() {
     int sampleCount = std::min(5, (int)testData.size());
     for (int i = 0; i < sampleCount; i++) {
         const auto& sample = testData[i];
-        auto result = nermal.query(sample.first);
+        auto result = nermal.queryBytes(sample.first);
         
         int predicted = std::max_element(result.begin(), result.end()) - result.begin();
         double confidence = *std::max_element(result.begin(), result.end());
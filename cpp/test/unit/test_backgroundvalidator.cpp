@@ -0,0 +1,132 @@
+#include "backgroundvalidator.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Evaluation function that replays a fixed sequence of scores
+static BackgroundValidator::EvaluateFunction scriptedScores(std::vector<double> scores) {
+    auto next = std::make_shared<size_t>(0);
+    return [scores, next](NeuralNetwork&) {
+        return scores[std::min((*next)++, scores.size() - 1)];
+    };
+}
+
+TEST(BackgroundValidatorTest, TracksBestSnapshot) {
+    NeuralNetwork nn(2, 3, 1, 0.5);
+    BackgroundValidator validator(scriptedScores({0.2, 0.6, 0.4}), 5);
+
+    for (int i = 0; i < 3; i++) {
+        validator.submitSnapshot(nn);
+        validator.waitForIdle();
+    }
+
+    EXPECT_EQ(validator.getEvaluatedCount(), 3);
+    EXPECT_EQ(validator.getBestSnapshotIndex(), 1);
+    EXPECT_NEAR(validator.getBestScore(), 0.6, 1e-12);
+    EXPECT_FALSE(validator.shouldStop());
+}
+
+TEST(BackgroundValidatorTest, PatienceRequestsStop) {
+    NeuralNetwork nn(2, 3, 1, 0.5);
+    BackgroundValidator validator(scriptedScores({0.5, 0.5, 0.49, 0.51}), 2, 0.05);
+
+    validator.submitSnapshot(nn);
+    validator.waitForIdle();
+    validator.submitSnapshot(nn);
+    validator.waitForIdle();
+    EXPECT_FALSE(validator.shouldStop());
+
+    // Third evaluation is the second in a row without improvement
+    validator.submitSnapshot(nn);
+    validator.waitForIdle();
+    EXPECT_TRUE(validator.shouldStop());
+    EXPECT_EQ(validator.getBestSnapshotIndex(), 0);
+}
+
+TEST(BackgroundValidatorTest, RestoreBestRecoversSnapshotWeights) {
+    NeuralNetwork nn(3, 5, 2, 0.3);
+    std::vector<double> inputs = {0.1, 0.5, 0.9};
+    std::vector<double> targets = {0.2, 0.8};
+
+    BackgroundValidator validator(scriptedScores({0.9, 0.1}), 5);
+    EXPECT_FALSE(validator.restoreBest(nn));
+
+    auto snapshotOutput = nn.query(inputs);
+    validator.submitSnapshot(nn);
+
+    // Keep training the live network while the snapshot is evaluated
+    for (int i = 0; i < 200; i++) {
+        nn.train(inputs, targets);
+    }
+    validator.waitForIdle();
+    validator.submitSnapshot(nn);
+    validator.waitForIdle();
+
+    ASSERT_TRUE(validator.restoreBest(nn));
+    auto restoredOutput = nn.query(inputs);
+    for (size_t i = 0; i < snapshotOutput.size(); i++) {
+        EXPECT_NEAR(restoredOutput[i], snapshotOutput[i], 1e-12);
+    }
+}
+
+TEST(BackgroundValidatorTest, SubmitDoesNotWaitForEvaluation) {
+    std::atomic<bool> release{false};
+    std::atomic<int> calls{0};
+    BackgroundValidator validator([&](NeuralNetwork&) {
+        calls++;
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return 0.5;
+    }, 10);
+
+    NeuralNetwork nn(2, 3, 1, 0.5);
+    validator.submitSnapshot(nn);
+    while (calls.load() == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Worker is stuck in the first evaluation; these must still return
+    for (int i = 0; i < 4; i++) {
+        validator.submitSnapshot(nn);
+    }
+    EXPECT_EQ(validator.getSkippedCount(), 3);
+
+    release = true;
+    validator.waitForIdle();
+    EXPECT_EQ(validator.getEvaluatedCount(), 2);
+}
+
+TEST(BackgroundValidatorTest, ThrowingEvaluationIsCountedAsFailed) {
+    std::atomic<int> calls{0};
+    BackgroundValidator validator([&](NeuralNetwork&) -> double {
+        if (calls++ == 0) {
+            throw std::runtime_error("validation data unavailable");
+        }
+        return 0.7;
+    }, 3);
+
+    NeuralNetwork nn(2, 3, 1, 0.5);
+    validator.submitSnapshot(nn);
+    validator.waitForIdle();
+    EXPECT_EQ(validator.getFailedCount(), 1);
+    EXPECT_EQ(validator.getEvaluatedCount(), 0);
+    EXPECT_FALSE(validator.restoreBest(nn));
+
+    // The worker keeps going after a failure
+    validator.submitSnapshot(nn);
+    validator.waitForIdle();
+    EXPECT_EQ(validator.getEvaluatedCount(), 1);
+    EXPECT_EQ(validator.getBestSnapshotIndex(), 1);
+}
+
+// Main function for running all tests
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -2,6 +2,23 @@
 #include <gtest/gtest.h>
 #include <vector>
 #include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// Number of threads in this process, or -1 where /proc is unavailable
+static int processThreadCount() {
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    while (status >> key) {
+        if (key == "Threads:") {
+            int threads;
+            status >> threads;
+            return threads;
+        }
+    }
+    return -1;
+}
 
 // Test fixture for NeuralNetwork tests
 class NeuralNetworkTest : public ::testing::Test {
@@ -118,6 +135,136 @@ TEST_F(NeuralNetworkTest, Serialization) {
     }
 }
 
+TEST_F(NeuralNetworkTest, IntraOpParallelismMatchesSerial) {
+    // Hidden layer wide enough for several row blocks, not a multiple of the block size
+    NeuralNetwork serial(20, 75, 3, 0.3);
+    NeuralNetwork parallel = serial;
+
+    std::vector<double> inputs(20);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        inputs[i] = 0.01 + 0.05 * i;
+    }
+    std::vector<double> targets = {0.1, 0.9, 0.5};
+
+    for (int i = 0; i < 20; i++) {
+        serial.train(inputs, targets);
+    }
+    auto serialOutput = serial.query(inputs);
+
+    int previousThreads = NeuralNetwork::getIntraOpThreads();
+    long long previousThreshold = NeuralNetwork::getIntraOpThreshold();
+    NeuralNetwork::setIntraOpThreads(4);
+    NeuralNetwork::setIntraOpThreshold(0);
+
+    for (int i = 0; i < 20; i++) {
+        parallel.train(inputs, targets);
+    }
+    auto parallelOutput = parallel.query(inputs);
+
+    NeuralNetwork::setIntraOpThreads(previousThreads);
+    NeuralNetwork::setIntraOpThreshold(previousThreshold);
+
+    ASSERT_EQ(parallelOutput.size(), serialOutput.size());
+    for (size_t i = 0; i < serialOutput.size(); i++) {
+        EXPECT_NEAR(parallelOutput[i], serialOutput[i], 1e-12);
+    }
+}
+
+TEST_F(NeuralNetworkTest, SwitchingIntraOpThreadsReusesPools) {
+    NeuralNetwork serial(20, 75, 3, 0.3);
+    NeuralNetwork parallel = serial;
+
+    std::vector<double> inputs(20);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        inputs[i] = 0.01 + 0.05 * i;
+    }
+    std::vector<double> targets = {0.1, 0.9, 0.5};
+
+    int previousThreads = NeuralNetwork::getIntraOpThreads();
+    long long previousThreshold = NeuralNetwork::getIntraOpThreshold();
+    NeuralNetwork::setIntraOpThreshold(0);
+
+    // Every step runs on a different thread count than the one before
+    int threadsAfterFirstRound = -1;
+    for (int round = 0; round < 20; round++) {
+        for (int threads : {2, 3}) {
+            NeuralNetwork::setIntraOpThreads(1);
+            serial.train(inputs, targets);
+            NeuralNetwork::setIntraOpThreads(threads);
+            parallel.train(inputs, targets);
+        }
+        if (round == 0) {
+            threadsAfterFirstRound = processThreadCount();
+        }
+    }
+    int threadsAfterLastRound = processThreadCount();
+    auto parallelOutput = parallel.query(inputs);
+    NeuralNetwork::setIntraOpThreads(1);
+    auto serialOutput = serial.query(inputs);
+
+    NeuralNetwork::setIntraOpThreads(previousThreads);
+    NeuralNetwork::setIntraOpThreshold(previousThreshold);
+
+    // Returning to a thread count reuses its pool instead of starting new threads
+    EXPECT_EQ(threadsAfterLastRound, threadsAfterFirstRound);
+    ASSERT_EQ(parallelOutput.size(), serialOutput.size());
+    for (size_t i = 0; i < serialOutput.size(); i++) {
+        EXPECT_NEAR(parallelOutput[i], serialOutput[i], 1e-12);
+    }
+}
+
+TEST_F(NeuralNetworkTest, ByteInputsMatchNormalizedInputs) {
+    NeuralNetwork bytes(6, 10, 3, 0.3);
+    NeuralNetwork doubles = bytes;
+    bytes.setInputTransform(0.99 / 255.0, 0.01);
+
+    std::vector<uint8_t> raw = {0, 255, 17, 0, 128, 3};
+    std::vector<double> normalized;
+    for (uint8_t value : raw) {
+        normalized.push_back(value / 255.0 * 0.99 + 0.01);
+    }
+    std::vector<double> targets = {0.01, 0.99, 0.01};
+
+    auto byteOutput = bytes.queryBytes(raw);
+    auto doubleOutput = doubles.query(normalized);
+    for (size_t i = 0; i < doubleOutput.size(); i++) {
+        EXPECT_NEAR(byteOutput[i], doubleOutput[i], 1e-12);
+    }
+
+    // Byte training must keep the folded bias term in step with the weights
+    for (int i = 0; i < 50; i++) {
+        bytes.trainBytes(raw, targets);
+        doubles.train(normalized, targets);
+    }
+    byteOutput = bytes.queryBytes(raw);
+    doubleOutput = doubles.query(normalized);
+    for (size_t i = 0; i < doubleOutput.size(); i++) {
+        EXPECT_NEAR(byteOutput[i], doubleOutput[i], 1e-9);
+    }
+
+    // Double-input training must keep the cached row sums in step too
+    bytes.train(normalized, targets);
+    doubles.train(normalized, targets);
+    byteOutput = bytes.queryBytes(raw);
+    doubleOutput = doubles.query(normalized);
+    for (size_t i = 0; i < doubleOutput.size(); i++) {
+        EXPECT_NEAR(byteOutput[i], doubleOutput[i], 1e-9);
+    }
+
+    // Byte training with a zero offset doesn't maintain the row sums; setting
+    // the offset again must rebuild them from the current weights
+    bytes.setInputTransform(0.99 / 255.0, 0.0);
+    for (int i = 0; i < 50; i++) {
+        bytes.trainBytes(raw, targets);
+    }
+    bytes.setInputTransform(0.99 / 255.0, 0.01);
+    byteOutput = bytes.queryBytes(raw);
+    doubleOutput = bytes.query(normalized);
+    for (size_t i = 0; i < doubleOutput.size(); i++) {
+        EXPECT_NEAR(byteOutput[i], doubleOutput[i], 1e-9);
+    }
+}
+
 // Main function for running all tests
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);